@@ -0,0 +1,470 @@
+/*
+  ==============================================================================
+
+    Copyright (c) 2022 - Gordon Webb
+
+    This file is part of Rain4Unity.
+
+    Wind4Unity1 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Wind4Unity1 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rain4Unity.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+/*
+  ==============================================================================
+
+    Headless soak test for Rain4UnityAudioProcessor.
+
+    Renders hours of audio as fast as possible with randomized parameter
+    automation, including stretches where the rain stops, across sample rates
+    and block sizes. Rendering runs with FTZ/DAZ off, and the test checks that
+    the filter states never go denormal, the output never contains
+    NaN/Inf/denormals and never trips the output guard.
+    Also checks the pieces the soak relies on: the output guard itself,
+    RainFilter decay without FTZ/DAZ, the intensity macro at its defaults and at
+    intensity 0, and slice-independent rendering.
+
+    Usage: Rain4UnitySoak [--hours H] [--seed N]
+    Exits with 0 when every check passes.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RainFilter.h"
+
+//==============================================================================
+struct OutputStats
+{
+    juce::int64 numNonFinite = 0;
+    juce::int64 numSubnormal = 0;
+    float peak = 0.f;
+
+    void scan(const float* data, int numSamples)
+    {
+        for (int s = 0; s < numSamples; ++s)
+        {
+            float x = data[s];
+            if (!std::isfinite(x))
+                ++numNonFinite;
+            else if (std::fpclassify(x) == FP_SUBNORMAL)
+                ++numSubnormal;
+            else
+                peak = juce::jmax(peak, std::abs(x));
+        }
+    }
+};
+
+static bool report(bool passed, const char* name)
+{
+    std::printf("%s  %s\n", passed ? "PASS" : "FAIL", name);
+    return passed;
+}
+
+static bool buffersMatch(const std::vector<float>& a, const std::vector<float>& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+//==============================================================================
+// The guard must let legitimate output through and reject anything non-finite or too loud.
+static bool checkOutputGuard()
+{
+    auto healthyWith = [](float value)
+    {
+        juce::AudioBuffer<float> buffer(Rain4UnityAudioProcessor::numOutputChannels, 64);
+        buffer.clear();
+        buffer.setSample(1, 63, value);
+        return Rain4UnityAudioProcessor::isOutputHealthy(buffer);
+    };
+
+    bool passed = healthyWith(0.f)
+               && healthyWith(-100.f)
+               && healthyWith(Rain4UnityAudioProcessor::maxOutputLevel)
+               && !healthyWith(Rain4UnityAudioProcessor::maxOutputLevel * 1.01f)
+               && !healthyWith(1.0e30f)
+               && !healthyWith(-1.0e30f)
+               && !healthyWith(std::numeric_limits<float>::quiet_NaN())
+               && !healthyWith(std::numeric_limits<float>::infinity())
+               && !healthyWith(-std::numeric_limits<float>::infinity());
+
+    return report(passed, "output guard rejects NaN, Inf and runaway levels");
+}
+
+//==============================================================================
+// Excite each filter type, then let it ring out into a minute of silence on a thread without
+// FTZ/DAZ. No output may go subnormal, and the cost should match a run with FTZ/DAZ set.
+static bool checkFilterDecay()
+{
+    const RainFilter::Type types[] = { RainFilter::Type::lowpass, RainFilter::Type::highpass,
+                                       RainFilter::Type::bandpass, RainFilter::Type::peak };
+    const char* typeNames[] = { "lowpass", "highpass", "bandpass", "peak" };
+    const double sampleRate = 48000.0;
+    const int tailSamples = static_cast<int>(sampleRate * 60.0);
+
+    auto renderTail = [&](RainFilter::Type type, OutputStats& stats)
+    {
+        RainFilter filter;
+        filter.prepare({ sampleRate, 512, 2 });
+        filter.setType(type);
+        filter.setCutoffFrequency(1000.f);
+        filter.setResonance(15.f);
+        filter.setPeakGain(1.25f);
+
+        juce::Random noise(1);
+        for (int s = 0; s < 1000; ++s)
+            filter.processSample(0, noise.nextFloat() * 2.f - 1.f);
+
+        float block[512];
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        for (int done = 0; done < tailSamples; done += 512)
+        {
+            for (int s = 0; s < 512; ++s)
+                block[s] = filter.processSample(0, 0.f);
+            stats.scan(block, 512);
+        }
+        return juce::Time::getMillisecondCounterHiRes() - start;
+    };
+
+    bool passed = true;
+    for (int i = 0; i < 4; ++i)
+    {
+        OutputStats withoutFtz, withFtz;
+        double msWithoutFtz = renderTail(types[i], withoutFtz);
+        double msWithFtz;
+        {
+            juce::ScopedNoDenormals noDenormals;
+            msWithFtz = renderTail(types[i], withFtz);
+        }
+
+        std::printf("      %-8s tail: %lld subnormal, %.1f ms without FTZ vs %.1f ms with FTZ\n",
+                    typeNames[i], withoutFtz.numSubnormal, msWithoutFtz, msWithFtz);
+        passed = passed && withoutFtz.numSubnormal == 0 && withoutFtz.numNonFinite == 0;
+    }
+
+    return report(passed, "RainFilter decays without denormals when FTZ/DAZ is off");
+}
+
+//==============================================================================
+static juce::AudioParameterBool* findMacroSwitch(Rain4UnityAudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+        if (auto* toggle = dynamic_cast<juce::AudioParameterBool*>(parameter))
+            return toggle;
+    return nullptr;
+}
+
+static std::vector<float> renderPlanarSlices(Rain4UnityAudioProcessor& processor, int numFrames, juce::Random* slicer, int maxSlice)
+{
+    std::vector<float> data(static_cast<size_t>(numFrames) * Rain4UnityAudioProcessor::numOutputChannels);
+    float* channels[] = { data.data(), data.data() + numFrames };
+
+    for (int start = 0; start < numFrames;)
+    {
+        int numSamples = slicer != nullptr ? 1 + static_cast<int>(slicer->nextFloat() * maxSlice) : maxSlice;
+        numSamples = juce::jmin(numSamples, numFrames - start);
+        float* offsetChannels[] = { channels[0] + start, channels[1] + start };
+        processor.renderPlanar(offsetChannels, numSamples);
+        start += numSamples;
+    }
+    return data;
+}
+
+// With the macro at its default position the lookup must reproduce the parameter defaults exactly.
+static bool checkMacroDefaults(juce::int64 seed)
+{
+    const double sampleRate = 48000.0;
+    const int numFrames = static_cast<int>(sampleRate * 10.0);
+
+    Rain4UnityAudioProcessor direct, macro;
+    auto* toggle = findMacroSwitch(macro);
+    if (toggle == nullptr)
+        return report(false, "macro at defaults matches the default parameters");
+    toggle->setValueNotifyingHost(1.f);
+
+    direct.setRandomSeed(seed);
+    macro.setRandomSeed(seed);
+    direct.prepareToPlay(sampleRate, 512);
+    macro.prepareToPlay(sampleRate, 512);
+
+    bool passed = buffersMatch(renderPlanarSlices(direct, numFrames, nullptr, 512),
+                               renderPlanarSlices(macro, numFrames, nullptr, 512));
+    return report(passed, "macro at defaults matches the default parameters");
+}
+
+// Intensity 0 on its own must stop the rain once the settings have glided there.
+static bool checkMacroSilence(juce::int64 seed)
+{
+    const double sampleRate = 48000.0;
+
+    Rain4UnityAudioProcessor processor;
+    auto* toggle = findMacroSwitch(processor);
+    if (toggle == nullptr)
+        return report(false, "macro at intensity 0 is silent");
+    toggle->setValueNotifyingHost(1.f);
+
+    processor.setRandomSeed(seed);
+    processor.prepareToPlay(sampleRate, 512);
+    renderPlanarSlices(processor, static_cast<int>(sampleRate * 2.0), nullptr, 512);
+
+    // Intensity is the parameter right after the macro switch
+    const auto& parameters = processor.getParameters();
+    for (int i = 0; i + 1 < static_cast<int>(parameters.size()); ++i)
+        if (parameters[i] == toggle)
+            parameters[i + 1]->setValueNotifyingHost(0.f);
+
+    renderPlanarSlices(processor, static_cast<int>(sampleRate * 2.0), nullptr, 512);
+    auto tail = renderPlanarSlices(processor, static_cast<int>(sampleRate * 5.0), nullptr, 512);
+
+    OutputStats stats;
+    stats.scan(tail.data(), static_cast<int>(tail.size()));
+    bool passed = stats.numNonFinite == 0 && stats.peak < 1.0e-6f;
+    std::printf("      peak after fading out: %g\n", stats.peak);
+    return report(passed, "macro at intensity 0 is silent");
+}
+
+//==============================================================================
+// Host blocks, random pulls, interleaved pulls and stem taps must all produce the same audio.
+static bool checkSliceInvariance(juce::int64 seed)
+{
+    const double sampleRate = 44100.0;
+    const int maxBlock = 480;
+    const int numFrames = static_cast<int>(sampleRate * 20.0);
+    const int numChannels = Rain4UnityAudioProcessor::numOutputChannels;
+
+    Rain4UnityAudioProcessor hosted, pulled, interleaved;
+    for (auto* processor : { &hosted, &pulled, &interleaved })
+    {
+        // Master gain is the first parameter. The default 0.5 scales exactly, so use a value
+        // that would expose any difference in where the gain is applied.
+        processor->getParameters()[0]->setValueNotifyingHost(0.37f);
+        processor->setRandomSeed(seed);
+        processor->prepareToPlay(sampleRate, maxBlock);
+    }
+
+    // Reference: fixed host blocks through processBlock()
+    std::vector<float> reference(static_cast<size_t>(numFrames) * numChannels);
+    {
+        juce::MidiBuffer midi;
+        float* channels[] = { reference.data(), reference.data() + numFrames };
+        for (int start = 0; start < numFrames; start += maxBlock)
+        {
+            juce::AudioBuffer<float> block(channels, numChannels, start, juce::jmin(maxBlock, numFrames - start));
+            hosted.processBlock(block, midi);
+        }
+    }
+
+    // Random pulls, some larger than the prepared block size
+    juce::Random slicer(seed);
+    bool planarMatches = buffersMatch(reference, renderPlanarSlices(pulled, numFrames, &slicer, maxBlock * 3));
+
+    // Interleaved pulls with every stem tapped
+    std::vector<float> master(static_cast<size_t>(numFrames) * numChannels);
+    std::vector<float> stems[Rain4UnityAudioProcessor::numStems];
+    float* stemPointers[Rain4UnityAudioProcessor::numStems];
+    for (int i = 0; i < Rain4UnityAudioProcessor::numStems; ++i)
+    {
+        stems[i].resize(master.size());
+        stemPointers[i] = stems[i].data();
+    }
+
+    for (int start = 0; start < numFrames;)
+    {
+        int numSamples = juce::jmin(1 + static_cast<int>(slicer.nextFloat() * 100), numFrames - start);
+        float* offsetStems[Rain4UnityAudioProcessor::numStems];
+        for (int i = 0; i < Rain4UnityAudioProcessor::numStems; ++i)
+            offsetStems[i] = stemPointers[i] + start * numChannels;
+        interleaved.renderInterleaved(master.data() + start * numChannels, numSamples, offsetStems);
+        start += numSamples;
+    }
+
+    bool interleavedMatches = true, stemsSum = true;
+    for (int s = 0; s < numFrames; ++s)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float value = master[static_cast<size_t>(s) * numChannels + ch];
+            interleavedMatches = interleavedMatches && value == reference[static_cast<size_t>(ch) * numFrames + s];
+
+            float sum = 0.f;
+            for (auto& stem : stems)
+                sum += stem[static_cast<size_t>(s) * numChannels + ch];
+            stemsSum = stemsSum && std::abs(sum - value) <= 1.0e-5f * juce::jmax(1.f, std::abs(value));
+        }
+    }
+
+    report(planarMatches, "random planar pulls match host blocks");
+    report(interleavedMatches, "interleaved pulls with stems match host blocks");
+    report(stemsSum, "stems sum to the main output");
+    return planarMatches && interleavedMatches && stemsSum;
+}
+
+//==============================================================================
+// Push a random subset of parameters to random values, often to the ends of their ranges.
+static void automate(Rain4UnityAudioProcessor& processor, juce::Random& random)
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (random.nextFloat() > 0.3f)
+            continue;
+
+        float value = random.nextFloat();
+        if (random.nextFloat() < 0.3f)
+            value = value < 0.5f ? 0.f : 1.f;
+        parameter->setValueNotifyingHost(value);
+    }
+}
+
+// Rain stopping: macro on at intensity 0 silences the layers, so the filter states ring down
+// towards the denormal range instead of being kept busy by the noise sources.
+static void stopRain(Rain4UnityAudioProcessor& processor)
+{
+    const auto& parameters = processor.getParameters();
+    for (int i = 0; i + 1 < static_cast<int>(parameters.size()); ++i)
+    {
+        if (dynamic_cast<juce::AudioParameterBool*>(parameters[i]) != nullptr)
+        {
+            parameters[i]->setValueNotifyingHost(1.f);
+            parameters[i + 1]->setValueNotifyingHost(0.f); // Intensity follows the macro switch
+            return;
+        }
+    }
+}
+
+static bool soak(double hours, juce::int64 seed)
+{
+    const double sampleRates[] = { 8000.0, 11025.0, 22050.0, 32000.0, 44100.0, 48000.0, 88200.0, 96000.0 };
+    const int blockSizes[] = { 16, 64, 256, 441, 512, 1024, 4096 };
+    const int numConfigs = static_cast<int>(std::size(sampleRates) * std::size(blockSizes));
+    const double secondsPerConfig = hours * 3600.0 / numConfigs;
+
+    std::printf("      soaking %.2f hours of audio, %.0f s per configuration\n", hours, secondsPerConfig);
+
+    bool passed = true;
+    double totalAudioSeconds = 0.0, totalMs = 0.0;
+    int config = 0;
+
+    for (double sampleRate : sampleRates)
+    {
+        for (int blockSize : blockSizes)
+        {
+            Rain4UnityAudioProcessor processor;
+            processor.setRandomSeed(seed + config);
+            processor.setFlushDenormals(false);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            juce::Random random(seed * 7919 + config++);
+            juce::AudioBuffer<float> buffer(Rain4UnityAudioProcessor::numOutputChannels, blockSize * 3);
+            juce::MidiBuffer midi;
+            OutputStats stats;
+
+            const auto totalSamples = static_cast<juce::int64>(secondsPerConfig * sampleRate);
+            juce::int64 done = 0, nextAutomation = 0, numSubnormalStates = 0;
+            double renderMs = 0.0;
+
+            while (done < totalSamples)
+            {
+                if (done >= nextAutomation)
+                {
+                    automate(processor, random);
+                    nextAutomation = done + static_cast<juce::int64>(sampleRate * (0.05 + random.nextFloat()));
+
+                    if (random.nextFloat() < 0.1f)
+                    {
+                        stopRain(processor);
+                        nextAutomation = done + static_cast<juce::int64>(sampleRate * (1.0 + 4.0 * random.nextFloat()));
+                    }
+                }
+
+                // Mostly regular host blocks, some short host blocks, some oversized pulls
+                float callType = random.nextFloat();
+                int numSamples = callType < 0.7f ? blockSize
+                               : callType < 0.9f ? 1 + static_cast<int>(random.nextFloat() * (blockSize - 1))
+                                                 : 1 + static_cast<int>(random.nextFloat() * (blockSize * 3 - 1));
+                numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), totalSamples - done));
+                juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), 0, numSamples);
+
+                auto start = juce::Time::getMillisecondCounterHiRes();
+                if (numSamples <= blockSize)
+                    processor.processBlock(block, midi);
+                else
+                    processor.renderPlanar(block.getArrayOfWritePointers(), numSamples);
+                renderMs += juce::Time::getMillisecondCounterHiRes() - start;
+
+                // Output scans can't see a denormal storm inside the filters, so check their state too
+                if (processor.hasSubnormalFilterState())
+                    ++numSubnormalStates;
+
+                for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                    stats.scan(block.getReadPointer(ch), numSamples);
+                done += numSamples;
+            }
+
+            bool configPassed = stats.numNonFinite == 0 && stats.numSubnormal == 0 && numSubnormalStates == 0
+                             && stats.peak <= Rain4UnityAudioProcessor::maxOutputLevel
+                             && processor.getNumOutputResets() == 0;
+            passed = passed && configPassed;
+
+            double audioSeconds = static_cast<double>(done) / sampleRate;
+            totalAudioSeconds += audioSeconds;
+            totalMs += renderMs;
+
+            std::printf("      %s %6.0f Hz %5d block: %7.0fx realtime, peak %6.2f, %lld non-finite, %lld subnormal, %lld subnormal filter states, %d guard resets\n",
+                        configPassed ? "ok  " : "FAIL", sampleRate, blockSize, audioSeconds * 1000.0 / juce::jmax(renderMs, 0.001),
+                        stats.peak, stats.numNonFinite, stats.numSubnormal,
+                        numSubnormalStates, processor.getNumOutputResets());
+        }
+    }
+
+    std::printf("      rendered %.2f hours in %.1f s, %.0fx realtime overall\n",
+                totalAudioSeconds / 3600.0, totalMs / 1000.0, totalAudioSeconds * 1000.0 / juce::jmax(totalMs, 0.001));
+    return report(passed, "soak without FTZ/DAZ stays finite, bounded and denormal-free");
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    double hours = 2.0;
+    juce::int64 seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--hours") == 0 && i + 1 < argc)
+            hours = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = std::atoll(argv[++i]);
+        else
+        {
+            std::printf("Usage: %s [--hours H] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("Rain4Unity soak test, seed %lld\n", seed);
+
+    bool passed = checkOutputGuard();
+    passed = checkFilterDecay() && passed;
+    passed = checkMacroDefaults(seed) && passed;
+    passed = checkMacroSilence(seed) && passed;
+    passed = checkSliceInvariance(seed) && passed;
+    passed = soak(hours, seed) && passed;
+
+    std::printf("%s\n", passed ? "All checks passed" : "Some checks FAILED");
+    return passed ? 0 : 1;
+}
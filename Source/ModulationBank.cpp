@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    ModulationBank.cpp
+
+  ==============================================================================
+*/
+
+#include "ModulationBank.h"
+
+void ModulationBank::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    reset();
+}
+
+void ModulationBank::reset()
+{
+    for (auto& lfo : lfos)
+    {
+        lfo.phase = 0.f;
+        lfo.fromValue = nextTarget();
+        lfo.toValue = nextTarget();
+        lfo.smoothRandom = lfo.fromValue;
+        lfo.sine = 0.f;
+    }
+}
+
+void ModulationBank::setFrequency(int slot, float frequency)
+{
+    lfos[slot].frequency = frequency;
+}
+
+void ModulationBank::tick(int numSamples)
+{
+    float elapsed = static_cast<float>(numSamples / currentSampleRate);
+
+    for (auto& lfo : lfos)
+    {
+        lfo.phase += lfo.frequency * elapsed;
+
+        // Above half the tick rate a tick can cover more than one period: step through every
+        // segment that ended so the current one starts where its predecessor finished
+        while (lfo.phase >= 1.f)
+        {
+            lfo.phase -= 1.f;
+            lfo.fromValue = lfo.toValue;
+            lfo.toValue = nextTarget();
+        }
+
+        lfo.smoothRandom = lfo.fromValue + (lfo.toValue - lfo.fromValue) * lfo.phase;
+        lfo.sine = std::sin(juce::MathConstants<float>::twoPi * lfo.phase);
+    }
+}
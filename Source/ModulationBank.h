@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ModulationBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Smoothed random and sine LFOs evaluated at control rate.
+// Each slot runs a phase accumulator that is advanced once per control tick. The random output
+// picks a new target every period and interpolates linearly towards it, each segment starting
+// where the last one ended, so the curve stays continuous at any rate. The sine output reads the
+// same phase. Reading a slot only returns the cached values. Rates above half the tick rate
+// are still followed, but a tick then samples the curve less than twice per period.
+// The bank belongs to one processor: each instance automates its own LFO rates and may run on
+// its own audio thread, so there is no common tick to share between instances.
+class ModulationBank
+{
+public:
+    enum Slot
+    {
+        midBoilCutoff = 0,
+        lowBoilCutoff,
+        numSlots
+    };
+
+    void prepare(double sampleRate);
+    void reset();
+    void setFrequency(int slot, float frequency);
+    void setSeed(juce::int64 seed) { r.setSeed(seed); }
+
+    // Called once per control tick, before any layer reads the bank
+    void tick(int numSamples);
+
+    // In [-1, 1]
+    float getSmoothRandom(int slot) const { return lfos[slot].smoothRandom; }
+    float getSine(int slot) const { return lfos[slot].sine; }
+
+private:
+    struct Lfo
+    {
+        float frequency = 1.f;
+        float phase = 0.f;
+        float fromValue = 0.f; // Sample-and-hold endpoints, interpolated over one period
+        float toValue = 0.f;
+        float smoothRandom = 0.f;
+        float sine = 0.f;
+    };
+
+    float nextTarget() { return r.nextFloat() * 2.0f - 1.0f; }
+
+    Lfo lfos[numSlots];
+    double currentSampleRate = 44100.0;
+    juce::Random r;
+};
@@ -4,9 +4,10 @@
 class PinkNoise
 {
 protected:
-	float b0, b1, b2, b3, b4, b5, b6;
+	float b0 = 0.f, b1 = 0.f, b2 = 0.f, b3 = 0.f, b4 = 0.f, b5 = 0.f, b6 = 0.f;
 	juce::Random r;
 public:
 	float nextFloat();
+	void setSeed(juce::int64 seed) { r.setSeed(seed); }
 };
 
@@ -29,6 +29,7 @@
 */
 
 #include "PluginProcessor.h"
+#include <optional>
 //#include "PluginEditor.h"
 
 //==============================================================================
@@ -95,6 +96,21 @@ Rain4UnityAudioProcessor::Rain4UnityAudioProcessor()
         "Drop Freq Interval", "Drop Freq Coef", 0.f, 9.0f, 3.0f));
     addParameter(dropTimeInterval = new juce::AudioParameterFloat(
         "Drop Time Interval", "Drop Time Coef", 0.f, 9.0f, 6.0f));
+
+    // Macro - added last so the indices of the parameters above stay stable for Unity
+    addParameter(macroEnabled = new juce::AudioParameterBool(
+        "Macro", "Intensity Macro", false));
+    addParameter(intensity = new juce::AudioParameterFloat(
+        "Intensity", "Rain Intensity", 0.f, 1.f, 0.5f));
+    addParameter(wind = new juce::AudioParameterFloat(
+        "Wind", "Wind", 0.f, 1.f, 0.f));
+    addParameter(surface = new juce::AudioParameterFloat(
+        "Surface", "Surface Hardness", 0.f, 1.f, 0.5f));
+
+    // The macro curves pass through the default values of the parameters above
+    RainSettings defaults;
+    readParameters(defaults);
+    macroTable.build(defaults);
 }
 
 static void mixAvg(juce::AudioBuffer<float>& buf, int destChannel, int destSample, float sample)
@@ -113,12 +129,23 @@ void Rain4UnityAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     //    Create DSP Spec
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = numOutputChannels; // Filters run on both channels
     spec.sampleRate = sampleRate;
     currentSpec = spec;
 
     //    Prepare DSP
     Prepare(spec);
+    snapSettings = true;
+
+    //    Control-rate work runs on its own fixed period, independent of how callers slice the output
+    controlPeriod = juce::jmax(1, static_cast<int>(std::round(sampleRate * controlPeriodSeconds)));
+    samplesUntilControlTick = 0;
+
+    //    Scratch buffers for the render paths, sized once here so rendering never allocates
+    tempBuffer.setSize(numOutputChannels, samplesPerBlock);
+    masterScratch.setSize(numOutputChannels, samplesPerBlock);
+    for (auto& stem : stemScratch)
+        stem.setSize(numOutputChannels, samplesPerBlock);
 }
 
 void Rain4UnityAudioProcessor::releaseResources()
@@ -129,19 +156,192 @@ void Rain4UnityAudioProcessor::releaseResources()
 
 void Rain4UnityAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ScopedNoDenormals noDenormals;
-    buffer.clear();
-    tempBuffer.setSize(buffer.getNumChannels(), buffer.getNumSamples()); // DO NOT RECREATE THIS BUFFER. Reuse it.
+    int numChannels = buffer.getNumChannels();
+    int numSamples = buffer.getNumSamples();
+
+    if (currentSpec.maximumBlockSize == 0) // prepareToPlay() has not been called
+    {
+        buffer.clear();
+        return;
+    }
+
+    if (numChannels >= numOutputChannels)
+    {
+        for (int ch = numOutputChannels; ch < numChannels; ++ch)
+            buffer.clear(ch, 0, numSamples);
+
+        renderPlanar(buffer.getArrayOfWritePointers(), numSamples);
+        return;
+    }
+
+    if (numChannels == 0)
+        return;
+
+    // Mono bus: render stereo into scratch and fold it down
+    int maxBlock = masterScratch.getNumSamples();
+    for (int start = 0; start < numSamples; start += maxBlock)
+    {
+        int chunkSize = juce::jmin(maxBlock, numSamples - start);
+        renderPlanar(masterScratch.getArrayOfWritePointers(), chunkSize);
+        buffer.copyFrom(0, start, masterScratch, 0, 0, chunkSize, 0.5f);
+        buffer.addFrom(0, start, masterScratch, 1, 0, chunkSize, 0.5f);
+    }
+}
+
+//==============================================================================
+void Rain4UnityAudioProcessor::renderPlanar(float* const* output, int numFrames, float* const* const* stemOutputs)
+{
+    std::optional<juce::ScopedNoDenormals> noDenormals;
+    if (flushDenormals)
+        noDenormals.emplace();
+
+    int maxBlock = static_cast<int>(currentSpec.maximumBlockSize);
+    jassert(maxBlock > 0); // prepareToPlay() has not been called
+    if (maxBlock <= 0)
+    {
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+            std::fill(output[ch], output[ch] + numFrames, 0.f);
+        for (int i = 0; stemOutputs != nullptr && i < numStems; ++i)
+            for (int ch = 0; stemOutputs[i] != nullptr && ch < numOutputChannels; ++ch)
+                std::fill(stemOutputs[i][ch], stemOutputs[i][ch] + numFrames, 0.f);
+        return;
+    }
+
+    int numSamples = 0;
+    for (int start = 0; start < numFrames; start += numSamples)
+    {
+        numSamples = beginChunk(juce::jmin(maxBlock, numFrames - start));
+        juce::AudioBuffer<float> out(output, numOutputChannels, start, numSamples);
+
+        // Caller buffers are written in place; untapped stems still need somewhere to render
+        juce::AudioBuffer<float> stems[numStems];
+        for (int i = 0; i < numStems; ++i)
+        {
+            if (stemOutputs != nullptr && stemOutputs[i] != nullptr)
+                stems[i].setDataToReferTo(stemOutputs[i], numOutputChannels, start, numSamples);
+            else
+                stems[i].setDataToReferTo(stemScratch[i].getArrayOfWritePointers(), numOutputChannels, 0, numSamples);
+        }
+        renderChunk(out, stems);
+    }
+}
+
+void Rain4UnityAudioProcessor::renderInterleaved(float* output, int numFrames, float* const* stemOutputs)
+{
+    std::optional<juce::ScopedNoDenormals> noDenormals;
+    if (flushDenormals)
+        noDenormals.emplace();
 
+    int maxBlock = static_cast<int>(currentSpec.maximumBlockSize);
+    jassert(maxBlock > 0); // prepareToPlay() has not been called
+    if (maxBlock <= 0)
+    {
+        std::fill(output, output + numFrames * numOutputChannels, 0.f);
+        for (int i = 0; stemOutputs != nullptr && i < numStems; ++i)
+            if (stemOutputs[i] != nullptr)
+                std::fill(stemOutputs[i], stemOutputs[i] + numFrames * numOutputChannels, 0.f);
+        return;
+    }
+
+    int numSamples = 0;
+    for (int start = 0; start < numFrames; start += numSamples)
+    {
+        numSamples = beginChunk(juce::jmin(maxBlock, numFrames - start));
+        juce::AudioBuffer<float> out(masterScratch.getArrayOfWritePointers(), numOutputChannels, 0, numSamples);
+
+        // The layers render planar, so the interleave pass is the only copy made here
+        juce::AudioBuffer<float> stems[numStems];
+        for (int i = 0; i < numStems; ++i)
+            stems[i].setDataToReferTo(stemScratch[i].getArrayOfWritePointers(), numOutputChannels, 0, numSamples);
+        renderChunk(out, stems);
+
+        for (int i = 0; stemOutputs != nullptr && i < numStems; ++i)
+            if (stemOutputs[i] != nullptr)
+                interleave(stems[i], stemOutputs[i] + start * numOutputChannels);
+        interleave(out, output + start * numOutputChannels);
+    }
+}
+
+int Rain4UnityAudioProcessor::beginChunk(int maxSamples)
+{
+    // Chunks never straddle a control tick, so the same samples hear the same control values
+    // no matter how the caller splits its requests
+    if (samplesUntilControlTick == 0)
+    {
+        controlTick();
+        samplesUntilControlTick = controlPeriod;
+    }
+
+    int numSamples = juce::jmin(maxSamples, samplesUntilControlTick);
+    samplesUntilControlTick -= numSamples;
+    return numSamples;
+}
+
+void Rain4UnityAudioProcessor::controlTick()
+{
     updateSettings();
+    modBank.tick(controlPeriod);
+    masterGain = gain->get();
+
+    // Mid-Boiling: random volume step and random BPF
+    float randomModulationDb = settings[RainSettings::mbRandomModulateAmplitude] * (r.nextFloat() * 2.0f - 1.0f);
+    mbRandomModulationGain = juce::Decibels::decibelsToGain(randomModulationDb);
 
-    midBoilProcess(buffer);
-    lowBoilProcess(buffer);
-    stereoBoilProcess(buffer);
-    dropProcess(buffer);
+    float centerFreq = settings[RainSettings::mbRngBPCenterFrequency];
+    float freqband = settings[RainSettings::mbRngBPOscAmplitude];
+    mbRngBPF.setCutoffFrequency(clampCutoff(modBank.getSmoothRandom(ModulationBank::midBoilCutoff) * freqband + centerFreq, minRandomCutoff));
+
+    // Low-Boiling: random BPF
+    centerFreq = settings[RainSettings::lbRngBPCenterFrequency];
+    freqband = settings[RainSettings::lbRngBPOscAmplitude];
+    lbRngBPF.setCutoffFrequency(clampCutoff(modBank.getSmoothRandom(ModulationBank::lowBoilCutoff) * freqband + centerFreq, minRandomCutoff));
+
+    // Drop: trigger
+    if (dropWave.finished() && r.nextFloat() < settings[RainSettings::dropTriggerChance])
+    {
+        dropWave.reset(settings[RainSettings::dropRetriggerTime], settings[RainSettings::dropTimeInterval], settings[RainSettings::dropFreqInterval]);
+    }
+}
+
+void Rain4UnityAudioProcessor::renderChunk(juce::AudioBuffer<float>& output, juce::AudioBuffer<float>* stems)
+{
+    int numSamples = output.getNumSamples();
+    tempBuffer.setSize(numOutputChannels, numSamples, false, false, true); // DO NOT RECREATE THIS BUFFER. Reuse it.
+
+    // Each layer always renders into its own stem and the main output is their sum, gained once,
+    // so it comes out the same whether or not the caller taps the stems
+    for (int i = 0; i < numStems; ++i)
+        stems[i].clear();
+
+    midBoilProcess(stems[midBoilStem]);
+    lowBoilProcess(stems[lowBoilStem]);
+    stereoBoilProcess(stems[stereoStem]);
+    dropProcess(stems[dropStem]);
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        output.copyFrom(ch, 0, stems[midBoilStem], ch, 0, numSamples);
+        output.addFrom(ch, 0, stems[lowBoilStem], ch, 0, numSamples);
+        output.addFrom(ch, 0, stems[stereoStem], ch, 0, numSamples);
+        output.addFrom(ch, 0, stems[dropStem], ch, 0, numSamples);
+    }
+    output.applyGain(masterGain);
+    for (int i = 0; i < numStems; ++i)
+        stems[i].applyGain(masterGain);
+
+    if (sanitizeOutput(output))
+        for (int i = 0; i < numStems; ++i)
+            stems[i].clear();
+}
 
-    buffer.applyGain(gain->get());
-    
+void Rain4UnityAudioProcessor::interleave(const juce::AudioBuffer<float>& source, float* dest)
+{
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        auto* src = source.getReadPointer(ch);
+        for (int s = 0; s < source.getNumSamples(); ++s)
+            dest[s * numOutputChannels + ch] = src[s];
+    }
 }
 
 //==============================================================================
@@ -159,86 +359,90 @@ juce::AudioProcessorEditor* Rain4UnityAudioProcessor::createEditor()
 
 void Rain4UnityAudioProcessor::Prepare(const juce::dsp::ProcessSpec& spec)
 {
+    nyquistCutoff = std::min(maxCutoff, static_cast<float>(spec.sampleRate) * maxCutoffRatio);
+
     //    Mid-Boiling
     mbBPF.prepare(spec);
-    mbBPF.setType(juce::dsp::StateVariableTPTFilterType::bandpass);
+    mbBPF.setType(RainFilter::Type::bandpass);
     mbBPF.setCutoffFrequency(10.0f);
     mbBPF.setResonance(1.0f);
     mbBPF.reset();
 
     mbRngBPF.prepare(spec);
-    mbRngBPF.setType(juce::dsp::StateVariableTPTFilterType::bandpass);
+    mbRngBPF.setType(RainFilter::Type::bandpass);
     mbRngBPF.setCutoffFrequency(1000.0f);
     mbRngBPF.setResonance(10.0f);
     mbRngBPF.reset();
 
-    mbRngBPOsc.initialise([](float x) { return std::sin(x); }, 128);
+    mbLPF.prepare(spec);
+    mbLPF.setType(RainFilter::Type::lowpass);
+    mbLPF.setCutoffFrequency(800.f);
+    mbLPF.setResonance(0.5f);
+    mbLPF.reset();
+
+    mbHPF.prepare(spec);
+    mbHPF.setType(RainFilter::Type::highpass);
+    mbHPF.setCutoffFrequency(3500.0f);
+    mbHPF.setResonance(1.2f);
+    mbHPF.reset();
 
 
     //  Low-Boiling
     lbLPF.prepare(spec);
-    lbLPF.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    lbLPF.setType(RainFilter::Type::lowpass);
     lbLPF.setCutoffFrequency(800.f);
     lbLPF.setResonance(0.5f);
     lbLPF.reset();
 
     lbHPF.prepare(spec);
-    lbHPF.setType(juce::dsp::StateVariableTPTFilterType::highpass);
+    lbHPF.setType(RainFilter::Type::highpass);
     lbHPF.setCutoffFrequency(3500.0f);
     lbHPF.setResonance(1.2f);
     lbHPF.reset();
 
     lbRngBPF.prepare(spec);
-    lbRngBPF.setType(juce::dsp::StateVariableTPTFilterType::bandpass);
+    lbRngBPF.setType(RainFilter::Type::bandpass);
     lbRngBPF.setCutoffFrequency(1000.f);
     lbRngBPF.setResonance(15.0f);
     lbRngBPF.reset();
 
-    lbRngBPOsc.initialise([](float x) { return std::sin(x); }, 128);
     // The L/HPF here are attenuation filters which get rid of some of the more out-of-place frequencies.
+    // They are linear, so mid-boiling runs through its own copy instead of sharing them with a summed buffer.
 
     // Stereo
-    stLPeakF.prepare(spec);
-    stLPeakF.coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(spec.sampleRate, 1000, 1.0f, 1);
-    stLPeakF.reset();
-
-    stRPeakF.prepare(spec);
-    stRPeakF.coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(spec.sampleRate, 1000, 1.0f, 1);
-    stRPeakF.reset();
+    stPeakF.prepare(spec);
+    stPeakF.setType(RainFilter::Type::peak);
+    stPeakF.setCutoffFrequency(1000.f);
+    stPeakF.setResonance(1.0f);
+    stPeakF.setPeakGain(1.25f);
+    stPeakF.reset();
 
     stLPF.prepare(spec);
-    stLPF.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+    stLPF.setType(RainFilter::Type::lowpass);
     stLPF.setCutoffFrequency(800.f);
     stLPF.setResonance(0.8f);
     stLPF.reset();
 
     stHPF.prepare(spec);
-    stHPF.setType(juce::dsp::StateVariableTPTFilterType::highpass);
+    stHPF.setType(RainFilter::Type::highpass);
     stHPF.setCutoffFrequency(2750.f);
     stHPF.setResonance(0.8f);
     stHPF.reset();
 
     // Drop
     dropWave.set_spec(spec);
+
+    // Modulation
+    modBank.prepare(spec.sampleRate);
 }
 
 void Rain4UnityAudioProcessor::midBoilProcess(juce::AudioBuffer<float>& buffer)
 {
     //    Get Buffer info
     int numSamples = buffer.getNumSamples();
-    float FrameAmp = mbGain->get();
-
-    // Random Modulation - Volume following an LFO
-    float randomModulationGain = mbRandomModulateAmplitude->get();
-    randomModulationGain *= r.nextFloat() * 2.0f - 1.0f;
-    randomModulationGain = juce::Decibels::decibelsToGain(randomModulationGain);
-
-    // random BPF
-    float centerFreq = mbRngBPCenterFrequency->get();
-    float freqband = mbRngBPOscAmplitude->get();
-    mbRngBPF.setCutoffFrequency(std::clamp(mbRngBPOsc.processSample(r.nextFloat() * 2.0f - 1.0f) * freqband + centerFreq, 25.f, 20000.0f));
-
+    float FrameAmp = settings[RainSettings::mbGain];
 
+    // Random modulation gain and the random BPF cutoff are picked in controlTick()
     for (int s = 0; s < numSamples; ++s)
     {
         float output = mbBPF.processSample(0, r.nextFloat() * 2.0f - 1.0f) * FrameAmp;
@@ -248,10 +452,9 @@ void Rain4UnityAudioProcessor::midBoilProcess(juce::AudioBuffer<float>& buffer)
         buffer.addSample(1, s, output);
     }
 
-    buffer.applyGain(randomModulationGain);
-  
-    mbBPF.snapToZero();
-    mbRngBPF.snapToZero();
+    buffer.applyGain(mbRandomModulationGain);
+
+    boilFilterProcess(buffer, mbLPF, mbHPF);
 }
 
 void Rain4UnityAudioProcessor::lowBoilProcess(juce::AudioBuffer<float>& buffer)
@@ -260,11 +463,6 @@ void Rain4UnityAudioProcessor::lowBoilProcess(juce::AudioBuffer<float>& buffer)
 
     int numSamples = buffer.getNumSamples();
 
-    // random BPF
-    float centerFreq = lbRngBPCenterFrequency->get();
-    float freqband = lbRngBPOscAmplitude->get();
-    lbRngBPF.setCutoffFrequency(std::clamp(lbRngBPOsc.processSample(r.nextFloat() * 2.0f - 1.0f) * freqband + centerFreq, 25.f, 20000.0f));
-
     for (int s = 0; s < numSamples; ++s)
     {
         float output = pr.nextFloat() * 2.0f - 1.0f;
@@ -273,32 +471,34 @@ void Rain4UnityAudioProcessor::lowBoilProcess(juce::AudioBuffer<float>& buffer)
         tempBuffer.addSample(1, s, output);
     }
 
-    tempBuffer.applyGain(lbGain->get());
+    tempBuffer.applyGain(settings[RainSettings::lbGain]);
 
     buffer.addFrom(0, 0, tempBuffer, 0, 0, numSamples, 1);
     buffer.addFrom(1, 0, tempBuffer, 1, 0, numSamples, 1);
 
-    // Filter the two boiling parts here
+    boilFilterProcess(buffer, lbLPF, lbHPF);
+}
+
+void Rain4UnityAudioProcessor::boilFilterProcess(juce::AudioBuffer<float>& buffer, RainFilter& lpf, RainFilter& hpf)
+{
+    int numSamples = buffer.getNumSamples();
+
     for (int s = 0; s < numSamples; ++s)
     {
-        float output = lbLPF.processSample(0, buffer.getSample(0, s));
-        output = lbHPF.processSample(0, output);
+        float output = lpf.processSample(0, buffer.getSample(0, s));
+        output = hpf.processSample(0, output);
         buffer.setSample(0, s, output);
 
-        output = lbLPF.processSample(1, buffer.getSample(1, s));
-        output = lbHPF.processSample(1, output);
+        output = lpf.processSample(1, buffer.getSample(1, s));
+        output = hpf.processSample(1, output);
         buffer.setSample(1, s, output);
     }
-
-    lbLPF.snapToZero();
-    lbHPF.snapToZero();
-    lbRngBPF.snapToZero();
 }
 
 void Rain4UnityAudioProcessor::stereoBoilProcess(juce::AudioBuffer<float>& buffer)
 {
     tempBuffer.clear();
-    float currentSTGain = stGain->get() / 2.0f;
+    float currentSTGain = settings[RainSettings::stGain] / 2.0f;
     int numSamples = buffer.getNumSamples();
 
     float panL1[2], panR1[2];
@@ -322,21 +522,12 @@ void Rain4UnityAudioProcessor::stereoBoilProcess(juce::AudioBuffer<float>& buffe
     tempBuffer.applyGain(currentSTGain);
     buffer.addFrom(0, 0, tempBuffer, 0, 0, numSamples, 1);
     buffer.addFrom(1, 0, tempBuffer, 1, 0, numSamples, 1);
-    
-    stLPF.snapToZero();
-    stHPF.snapToZero();
-    stLPeakF.snapToZero();
-    stRPeakF.snapToZero();
 }
 
 void Rain4UnityAudioProcessor::dropProcess(juce::AudioBuffer<float>& buffer)
 {
     int numSamples = buffer.getNumSamples();
-	// Trigger
-    if(dropWave.finished() && r.nextFloat() > 0.9f)
-    {
-        dropWave.reset(dropRetriggerTime->get(), dropTimeInterval->get(), dropFreqInterval->get());
-    }
+	// Trigger happens in controlTick()
     // Process
     tempBuffer.clear();
     // a. Pan
@@ -351,7 +542,7 @@ void Rain4UnityAudioProcessor::dropProcess(juce::AudioBuffer<float>& buffer)
         tempBuffer.setSample(1, s, output * pan[1]);
     }
 
-    tempBuffer.applyGain(dropGain->get());
+    tempBuffer.applyGain(settings[RainSettings::dropGain]);
 
     buffer.addFrom(0, 0, tempBuffer, 0, 0, numSamples, 1);
     buffer.addFrom(1, 0, tempBuffer, 1, 0, numSamples, 1);
@@ -362,36 +553,84 @@ void Rain4UnityAudioProcessor::updateSettings()
 {
     //  UpdateWSCircularBuffer;
 
-    float currentMBCutoff = mbBPCutoff->get();
-    float currentDstResonance = mbBPQ->get();
-    float currentMBRngFrequency = mbRngBPOscFrequency->get();
-    float currentMBRngQ = mbRngBPQ->get();
+    if (macroEnabled->get())
+        macroTable.lookup(intensity->get(), wind->get(), surface->get(), targetSettings);
+    else
+        readParameters(targetSettings);
+
+    // Glide towards the new values over a few ticks so macro jumps and toggles don't click
+    if (snapSettings)
+    {
+        settings = targetSettings;
+        snapSettings = false;
+    }
+    else
+    {
+        for (int n = 0; n < RainSettings::numFields; ++n)
+            settings.values[n] += (targetSettings.values[n] - settings.values[n]) * settingsSmoothing;
+    }
+
+    float currentMBCutoff = settings[RainSettings::mbBPCutoff];
+    float currentDstResonance = settings[RainSettings::mbBPQ];
+    float currentMBRngFrequency = settings[RainSettings::mbRngBPOscFrequency];
+    float currentMBRngQ = settings[RainSettings::mbRngBPQ];
 
-    float currentLBLPFCutoff = lbLPFCutoff->get();
-    float currentLBHPFCutoff = lbHPFCutoff->get();
-    float currentLBRngFrequency = lbRngBPOscFrequency->get();
-    float currentLBBPQ = lbRngBPQ->get();
+    float currentLBLPFCutoff = settings[RainSettings::lbLPFCutoff];
+    float currentLBHPFCutoff = settings[RainSettings::lbHPFCutoff];
+    float currentLBRngFrequency = settings[RainSettings::lbRngBPOscFrequency];
+    float currentLBBPQ = settings[RainSettings::lbRngBPQ];
 
-    float currentSTLPFCutoff = stLPFCutoff->get();
-    float currentSTHPFCutoff = stHPFCutoff->get();
-    float currentSTPeakFreq = stPeakFreq->get();
+    float currentSTLPFCutoff = settings[RainSettings::stLPFCutoff];
+    float currentSTHPFCutoff = settings[RainSettings::stHPFCutoff];
+    float currentSTPeakFreq = clampCutoff(settings[RainSettings::stPeakFreq]);
 
     // Update DST Filter Settings
-    mbBPF.setCutoffFrequency(currentMBCutoff);
+    mbBPF.setCutoffFrequency(clampCutoff(currentMBCutoff));
     mbBPF.setResonance(currentDstResonance);
     mbRngBPF.setResonance(currentMBRngQ);
-    mbRngBPOsc.setFrequency(currentMBRngFrequency);
+    modBank.setFrequency(ModulationBank::midBoilCutoff, currentMBRngFrequency);
 
-    lbLPF.setCutoffFrequency(currentLBLPFCutoff);
-    lbHPF.setCutoffFrequency(currentLBHPFCutoff);
-    lbRngBPOsc.setFrequency(currentLBRngFrequency);
+    lbLPF.setCutoffFrequency(clampCutoff(currentLBLPFCutoff));
+    lbHPF.setCutoffFrequency(clampCutoff(currentLBHPFCutoff));
+    mbLPF.setCutoffFrequency(clampCutoff(currentLBLPFCutoff));
+    mbHPF.setCutoffFrequency(clampCutoff(currentLBHPFCutoff));
+    modBank.setFrequency(ModulationBank::lowBoilCutoff, currentLBRngFrequency);
     lbRngBPF.setResonance(currentLBBPQ);
 
-    stLPF.setCutoffFrequency(currentSTLPFCutoff);
-    stHPF.setCutoffFrequency(currentSTHPFCutoff);
-    stLPeakF.coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), currentSTPeakFreq, 1, 1.25f);
-    stRPeakF.coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), currentSTPeakFreq, 1, 1.25f);
-    
+    stLPF.setCutoffFrequency(clampCutoff(currentSTLPFCutoff));
+    stHPF.setCutoffFrequency(clampCutoff(currentSTHPFCutoff));
+    stPeakF.setCutoffFrequency(currentSTPeakFreq);
+}
+
+void Rain4UnityAudioProcessor::readParameters(RainSettings& st) const
+{
+    st[RainSettings::mbGain] = mbGain->get();
+    st[RainSettings::mbBPCutoff] = mbBPCutoff->get();
+    st[RainSettings::mbBPQ] = mbBPQ->get();
+    st[RainSettings::mbRandomModulateAmplitude] = mbRandomModulateAmplitude->get();
+    st[RainSettings::mbRngBPOscAmplitude] = mbRngBPOscAmplitude->get();
+    st[RainSettings::mbRngBPCenterFrequency] = mbRngBPCenterFrequency->get();
+    st[RainSettings::mbRngBPOscFrequency] = mbRngBPOscFrequency->get();
+    st[RainSettings::mbRngBPQ] = mbRngBPQ->get();
+
+    st[RainSettings::lbGain] = lbGain->get();
+    st[RainSettings::lbRngBPOscAmplitude] = lbRngBPOscAmplitude->get();
+    st[RainSettings::lbRngBPCenterFrequency] = lbRngBPCenterFrequency->get();
+    st[RainSettings::lbRngBPOscFrequency] = lbRngBPOscFrequency->get();
+    st[RainSettings::lbRngBPQ] = lbRngBPQ->get();
+    st[RainSettings::lbLPFCutoff] = lbLPFCutoff->get();
+    st[RainSettings::lbHPFCutoff] = lbHPFCutoff->get();
+
+    st[RainSettings::stGain] = stGain->get();
+    st[RainSettings::stLPFCutoff] = stLPFCutoff->get();
+    st[RainSettings::stHPFCutoff] = stHPFCutoff->get();
+    st[RainSettings::stPeakFreq] = stPeakFreq->get();
+
+    st[RainSettings::dropGain] = dropGain->get();
+    st[RainSettings::dropRetriggerTime] = dropRetriggerTime->get();
+    st[RainSettings::dropFreqInterval] = dropFreqInterval->get();
+    st[RainSettings::dropTimeInterval] = dropTimeInterval->get();
+    st[RainSettings::dropTriggerChance] = defaultDropTriggerChance;
 }
 
 void Rain4UnityAudioProcessor::cosPan(float* output, float pan)
@@ -402,11 +641,77 @@ void Rain4UnityAudioProcessor::cosPan(float* output, float pan)
 
 void Rain4UnityAudioProcessor::stProcessSample(int channel, float& sample)
 {
-    sample = channel == 0 ? stLPeakF.processSample(sample) : stRPeakF.processSample(sample);
+    sample = stPeakF.processSample(channel, sample);
     sample = stLPF.processSample(channel, sample);
     sample = stHPF.processSample(channel, sample);
 }
 
+float Rain4UnityAudioProcessor::clampCutoff(float frequency, float lowest) const
+{
+    // At low sample rates the upper bound must follow Nyquist, otherwise high-Q SVFs blow up.
+    return std::clamp(frequency, lowest, nyquistCutoff);
+}
+
+bool Rain4UnityAudioProcessor::isOutputHealthy(const juce::AudioBuffer<float>& buffer)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* data = buffer.getReadPointer(ch);
+        for (int s = 0; s < buffer.getNumSamples(); ++s)
+        {
+            // Written so that NaN also fails the comparison
+            if (!(std::abs(data[s]) <= maxOutputLevel))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Rain4UnityAudioProcessor::sanitizeOutput(juce::AudioBuffer<float>& buffer)
+{
+    // Last line of defense: if any layer went unstable, drop the block and restart the filters
+    // rather than handing NaN/Inf or a runaway resonance to the host for the rest of the session.
+    if (isOutputHealthy(buffer))
+        return false;
+
+    buffer.clear();
+    resetFilters();
+    ++numOutputResets;
+    return true;
+}
+
+void Rain4UnityAudioProcessor::setRandomSeed(juce::int64 seed)
+{
+    r.setSeed(seed);
+    pr.setSeed(seed + 1);
+    stereoPnL1.setSeed(seed + 2);
+    stereoPnR1.setSeed(seed + 3);
+    dropWave.set_seed(seed + 4);
+    modBank.setSeed(seed + 5);
+}
+
+bool Rain4UnityAudioProcessor::hasSubnormalFilterState() const
+{
+    for (auto* filter : { &mbBPF, &mbRngBPF, &mbLPF, &mbHPF, &lbLPF, &lbHPF, &lbRngBPF, &stLPF, &stHPF, &stPeakF })
+        if (filter->hasSubnormalState())
+            return true;
+    return false;
+}
+
+void Rain4UnityAudioProcessor::resetFilters()
+{
+    mbBPF.reset();
+    mbRngBPF.reset();
+    mbLPF.reset();
+    mbHPF.reset();
+    lbLPF.reset();
+    lbHPF.reset();
+    lbRngBPF.reset();
+    stLPF.reset();
+    stHPF.reset();
+    stPeakF.reset();
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -33,6 +33,9 @@
 #include <JuceHeader.h>
 #include "PinkNoise.h"
 #include "RainDropWave.h"
+#include "ModulationBank.h"
+#include "RainFilter.h"
+#include "RainMacroTable.h"
 
 //==============================================================================
 
@@ -76,29 +79,82 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override{}
     void setStateInformation (const void* data, int sizeInBytes) override{}
 
+    //==============================================================================
+    // Pull-based rendering for consumers outside a plugin host.
+    // Call prepareToPlay() first; numFrames can be any size and is split internally into
+    // blocks of at most samplesPerBlock. Control-rate work runs on a fixed period of its own, so the
+    // output does not depend on how requests are sliced. Output is stereo: renderPlanar() writes
+    // straight into the caller's channels, renderInterleaved() renders planar and interleaves a copy.
+    // stemOutputs is an optional array of numStems taps, one per layer (nullptr entries are skipped),
+    // in the same layout as the main output. Stems are post master gain and sum to the main output;
+    // tapping them does not change the main output. Must not run concurrently with processBlock().
+    enum Stem
+    {
+        midBoilStem = 0,
+        lowBoilStem,
+        stereoStem,
+        dropStem,
+        numStems
+    };
+
+    void renderPlanar(float* const* output, int numFrames, float* const* const* stemOutputs = nullptr);
+    void renderInterleaved(float* output, int numFrames, float* const* stemOutputs = nullptr);
+
+    // Output guard. A block fails if any sample is NaN/Inf or louder than maxOutputLevel;
+    // failed blocks are silenced and every filter is reset.
+    static bool isOutputHealthy(const juce::AudioBuffer<float>& buffer);
+    int getNumOutputResets() const { return numOutputResets; }
+
+    // Seeds every random source so a render can be reproduced. Call before prepareToPlay().
+    void setRandomSeed(juce::int64 seed);
+
+    // For the soak test: rendering normally sets FTZ/DAZ, which hides denormals in the filter
+    // state. Turning it off runs the synthesis the way a thread without FTZ/DAZ would.
+    void setFlushDenormals(bool shouldFlush) { flushDenormals = shouldFlush; }
+    bool hasSubnormalFilterState() const;
+
     // Data Structs
 
     // Constants
     static const int wSCBSize = 500;
     static const int numOutputChannels = 2;
     static const int maxPanFrames = 20;
+    static constexpr float minCutoff = 15.f; // Lowest value of the cutoff parameters
+    static constexpr float minRandomCutoff = 25.f; // Floor for the randomly swept BPFs
+    static constexpr float maxCutoff = 20000.f;
+    static constexpr float maxCutoffRatio = 0.45f; // Keep SVF cutoffs safely below Nyquist
+    static constexpr float maxOutputLevel = 1000.f; // +60dBFS; every gain and Q maxed out peaks around +40dBFS
+    static constexpr float defaultDropTriggerChance = 0.1f;
+    static constexpr float settingsSmoothing = 0.25f; // Fraction of the remaining distance covered per control tick
+    static constexpr double controlPeriodSeconds = 0.01; // Settings, modulation and drop triggers update at 100Hz
 
 
 private:
 
     //  Wind Methods
     void Prepare(const juce::dsp::ProcessSpec& spec);
+    int beginChunk(int maxSamples);
+    void controlTick();
+    void renderChunk(juce::AudioBuffer<float>& output, juce::AudioBuffer<float>* stems);
+    void interleave(const juce::AudioBuffer<float>& source, float* dest);
     void midBoilProcess(juce::AudioBuffer<float>& buffer);
     void lowBoilProcess(juce::AudioBuffer<float>& buffer);
+    void boilFilterProcess(juce::AudioBuffer<float>& buffer, RainFilter& lpf, RainFilter& hpf);
     void stereoBoilProcess(juce::AudioBuffer<float>& buffer);
     void dropProcess(juce::AudioBuffer<float>& buffer);
     void updateSettings();
+    void readParameters(RainSettings& st) const;
     void cosPan(float* output, float pan);
     void stProcessSample(int channel, float& sample);
+    float clampCutoff(float frequency, float lowest = minCutoff) const;
+    bool sanitizeOutput(juce::AudioBuffer<float>& buffer);
+    void resetFilters();
 
     //  Global Parameters
     juce::AudioParameterFloat* gain;
     juce::AudioBuffer<float> tempBuffer; // For adjust component gains
+    juce::AudioBuffer<float> masterScratch; // Planar output before interleaving
+    juce::AudioBuffer<float> stemScratch[numStems]; // Layers the caller did not tap
 
     //  Mid-Boiling
     juce::AudioParameterFloat* mbBPCutoff;
@@ -133,32 +189,52 @@ private:
     juce::AudioParameterFloat* dropFreqInterval;
     juce::AudioParameterFloat* dropTimeInterval;
 
+    // Macro - drives every layer from one intensity value when enabled
+    juce::AudioParameterBool* macroEnabled;
+    juce::AudioParameterFloat* intensity;
+    juce::AudioParameterFloat* wind;
+    juce::AudioParameterFloat* surface;
 
     //  Boiling Component
     juce::Random r;
     PinkNoise pr;
-    juce::dsp::StateVariableTPTFilter<float> mbBPF;
-    juce::dsp::StateVariableTPTFilter<float> mbRngBPF;
-    juce::dsp::Oscillator<float> mbRngBPOsc;
-
-    juce::dsp::Oscillator<float> lbRngBPOsc;
-    juce::dsp::StateVariableTPTFilter<float> lbLPF;
-    juce::dsp::StateVariableTPTFilter<float> lbHPF;
-    juce::dsp::StateVariableTPTFilter<float> lbRngBPF;
+    RainFilter mbBPF;
+    RainFilter mbRngBPF;
+    RainFilter mbLPF; // Same settings as lbLPF/lbHPF, so each boiling layer has its own stem
+    RainFilter mbHPF;
+
+    RainFilter lbLPF;
+    RainFilter lbHPF;
+    RainFilter lbRngBPF;
     
     // Stereo Component
     PinkNoise stereoPnL1;
     PinkNoise stereoPnR1;
-    juce::dsp::StateVariableTPTFilter<float> stLPF;
-    juce::dsp::StateVariableTPTFilter<float> stHPF;
-    juce::dsp::IIR::Filter<float> stLPeakF;
-    juce::dsp::IIR::Filter<float> stRPeakF;
+    RainFilter stLPF;
+    RainFilter stHPF;
+    RainFilter stPeakF;
 
     // Drop Component
     RainDropWave dropWave;
 
+    // Modulation shared by all layers
+    ModulationBank modBank;
+
+    // Per-tick values, from the individual parameters or the macro table
+    RainSettings targetSettings;
+    RainSettings settings; // Smoothed towards targetSettings every control tick
+    bool snapSettings = true;
+    RainMacroTable macroTable;
+
     //  Internal Variables
-    juce::dsp::ProcessSpec currentSpec;
+    juce::dsp::ProcessSpec currentSpec {};
+    float nyquistCutoff = maxCutoff;
+    int numOutputResets = 0;
+    bool flushDenormals = true;
+    int controlPeriod = 1;
+    int samplesUntilControlTick = 0;
+    float masterGain = 0.f;
+    float mbRandomModulationGain = 1.f;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Rain4UnityAudioProcessor)
@@ -22,6 +22,7 @@ void RainDropWave::reset(float end_time, float interval_coeff, float freq_coeff)
     m = 3 + freq_coeff * rand_num_new(12);
     f = 1000 + freq_coeff * rand_num_new(1000);
     time = 0.f;
+    sampleIndex = 0;
     pan = remap(r.nextFloat(), 0, 0.48f, 1.f, 0.52f);
 }
 
@@ -34,8 +35,13 @@ float RainDropWave::GetNext()
 {
     float value = 0.f;
 
-    float unit_time = static_cast<float>(1.0 / currentSpec.sampleRate);
-    time += unit_time;
+    if (finished())
+    {
+        return value;
+    }
+
+    ++sampleIndex;
+    time = static_cast<float>(static_cast<double>(sampleIndex) / currentSpec.sampleRate);
 
     if (time < t_init)
     {
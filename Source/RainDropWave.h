@@ -17,6 +17,7 @@ class RainDropWave
 
 private:
     float time = 0.f;
+    juce::int64 sampleIndex = 0; // time is derived from this so it never drifts over long sessions
     float t_init = 0.001f;
     float delta_t_1 = 0.002f;
     float delta_t_2 = 0.006f;
@@ -36,6 +37,10 @@ public:
     {
         currentSpec = spec;
     }
+    void set_seed(juce::int64 seed)
+    {
+        r.setSeed(seed);
+    }
 
     // Called for each trigger
     void reset(float end_time, float interval_coeff, float freq_coeff);
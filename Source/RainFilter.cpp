@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    RainFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "RainFilter.h"
+
+void RainFilter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= static_cast<juce::uint32>(maxChannels));
+    sampleRate = spec.sampleRate;
+    numChannels = juce::jlimit(1, maxChannels, static_cast<int>(spec.numChannels));
+    update();
+    reset();
+}
+
+void RainFilter::reset()
+{
+    for (int ch = 0; ch < maxChannels; ++ch)
+    {
+        s1[ch] = 0.f;
+        s2[ch] = 0.f;
+    }
+}
+
+bool RainFilter::hasSubnormalState() const
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        if (std::fpclassify(s1[ch]) == FP_SUBNORMAL || std::fpclassify(s2[ch]) == FP_SUBNORMAL)
+            return true;
+    return false;
+}
+
+void RainFilter::setType(Type newType)
+{
+    type = newType;
+    update();
+}
+
+void RainFilter::setCutoffFrequency(float frequency)
+{
+    jassert(frequency > 0 && frequency < static_cast<float>(sampleRate * 0.5));
+    cutoffFrequency = frequency;
+    update();
+}
+
+void RainFilter::setResonance(float newResonance)
+{
+    jassert(newResonance > 0);
+    resonance = newResonance;
+    update();
+}
+
+void RainFilter::setPeakGain(float newGainFactor)
+{
+    jassert(newGainFactor > 0);
+    peakGain = newGainFactor;
+    update();
+}
+
+void RainFilter::update()
+{
+    g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * cutoffFrequency / sampleRate));
+
+    if (type == Type::peak)
+    {
+        // Bell with the same response as IIR::Coefficients::makePeakFilter:
+        // A = sqrt(gain), damping 1/(Q*A), band gain added back as (A^2 - 1) * damping.
+        float A = std::sqrt(peakGain);
+        R2 = 1.f / (resonance * A);
+        peakMix = R2 * (A * A - 1.f);
+    }
+    else
+    {
+        R2 = 1.f / resonance;
+        peakMix = 0.f;
+    }
+
+    h = 1.f / (1.f + R2 * g + g * g);
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    RainFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// TPT state variable filter used by the boiling and stereo layers.
+// Same topology as juce::dsp::StateVariableTPTFilter, plus a peak mode that replaces
+// the IIR peak filters. A tiny noise floor (~-360dB) is injected at the input so the
+// integrator states never decay into the denormal range; no snapToZero() pass is needed
+// and the cost is the same whether or not FTZ/DAZ is set on the audio thread.
+class RainFilter
+{
+public:
+    enum class Type
+    {
+        lowpass,
+        highpass,
+        bandpass,
+        peak
+    };
+
+    static const int maxChannels = 2;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setType(Type newType);
+    void setCutoffFrequency(float frequency);
+    void setResonance(float newResonance);
+    void setPeakGain(float newGainFactor); // Linear gain at the cutoff, peak mode only
+
+    // True if any integrator state has decayed into the denormal range
+    bool hasSubnormalState() const;
+
+    float processSample(int channel, float inputValue)
+    {
+        jassert(channel >= 0 && channel < numChannels);
+
+        auto& ls1 = s1[channel];
+        auto& ls2 = s2[channel];
+
+        float yHP = h * (inputValue + nextAntiDenormal() - ls1 * (g + R2) - ls2);
+        float yBP = yHP * g + ls1;
+        ls1 = yHP * g + yBP;
+        float yLP = yBP * g + ls2;
+        ls2 = yBP * g + yLP;
+
+        switch (type)
+        {
+            case Type::lowpass:  return yLP;
+            case Type::highpass: return yHP;
+            case Type::bandpass: return yBP;
+            case Type::peak:     return inputValue + peakMix * yBP;
+        }
+        return yBP;
+    }
+
+private:
+    void update();
+
+    float nextAntiDenormal()
+    {
+        noiseSeed = noiseSeed * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<juce::int32>(noiseSeed)) * antiDenormalScale;
+    }
+
+    static constexpr float antiDenormalScale = 1.0e-18f / 2147483648.0f;
+
+    Type type = Type::lowpass;
+    float cutoffFrequency = 1000.f;
+    float resonance = 1.f / juce::MathConstants<float>::sqrt2;
+    float peakGain = 1.f;
+    double sampleRate = 44100.0;
+    int numChannels = maxChannels;
+
+    float g = 0.f, h = 0.f, R2 = 0.f, peakMix = 0.f;
+    float s1[maxChannels] = {};
+    float s2[maxChannels] = {};
+    juce::uint32 noiseSeed = 22222u;
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    RainMacroTable.cpp
+
+  ==============================================================================
+*/
+
+#include "RainMacroTable.h"
+
+static void locate(float value, int steps, int& index, float& frac)
+{
+    float pos = juce::jlimit(0.f, 1.f, value) * static_cast<float>(steps - 1);
+    index = juce::jmin(static_cast<int>(pos), steps - 2);
+    frac = pos - static_cast<float>(index);
+}
+
+void RainMacroTable::build(const RainSettings& defaults)
+{
+    table.resize(intensitySteps * windSteps * surfaceSteps);
+
+    for (int i = 0; i < intensitySteps; ++i)
+        for (int w = 0; w < windSteps; ++w)
+            for (int s = 0; s < surfaceSteps; ++s)
+                table[(i * windSteps + w) * surfaceSteps + s] = evaluate(defaults,
+                    static_cast<float>(i) / (intensitySteps - 1),
+                    static_cast<float>(w) / (windSteps - 1),
+                    static_cast<float>(s) / (surfaceSteps - 1));
+}
+
+void RainMacroTable::lookup(float intensity, float wind, float surface, RainSettings& result) const
+{
+    jassert(!table.empty()); // build() has not been called
+
+    int i, w, s;
+    float fi, fw, fs;
+    locate(intensity, intensitySteps, i, fi);
+    locate(wind, windSteps, w, fw);
+    locate(surface, surfaceSteps, s, fs);
+
+    result.values.fill(0.f);
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        int di = corner & 1, dw = (corner >> 1) & 1, ds = (corner >> 2) & 1;
+        float weight = (di ? fi : 1.f - fi) * (dw ? fw : 1.f - fw) * (ds ? fs : 1.f - fs);
+        const auto& point = at(i + di, w + dw, s + ds);
+
+        for (int n = 0; n < RainSettings::numFields; ++n)
+            result.values[n] += point.values[n] * weight;
+    }
+}
+
+RainSettings RainMacroTable::evaluate(const RainSettings& defaults, float intensity, float wind, float surface)
+{
+    // Every curve is a factor on the default value: intensity and surface pass through 1 at 0.5,
+    // wind starts at 1 with no wind. Factors are kept inside the ranges of the matching parameters,
+    // except that every gain and the drop trigger chance reach 0 at intensity 0 so the rain stops.
+    auto lerp = [](float from, float to, float t) { return from + (to - from) * t; };
+    auto around = [&lerp](float atZero, float atOne, float t)
+    {
+        return t < 0.5f ? lerp(atZero, 1.f, t * 2.f) : lerp(1.f, atOne, t * 2.f - 1.f);
+    };
+    auto gainCurve = [](float t) { return 4.f * t * t; }; // Perceived loudness grows faster than linearly
+    auto fadeIn = [](float t) { return juce::jmin(1.f, t * 8.f); }; // Full strength from intensity 0.125
+    auto windCurve = [&lerp, wind](float atOne) { return lerp(1.f, atOne, wind); };
+
+    RainSettings st = defaults;
+
+    //  Mid-Boiling: the dense bed of small drops, brighter on hard surfaces
+    st[RainSettings::mbGain] *= gainCurve(intensity);
+    st[RainSettings::mbBPCutoff] *= around(0.7f, 1.3f, surface);
+    st[RainSettings::mbRandomModulateAmplitude] *= around(0.6f, 9.f / 7.f, intensity);
+    st[RainSettings::mbRngBPOscAmplitude] *= around(0.7f, 1.3f, intensity);
+    st[RainSettings::mbRngBPCenterFrequency] *= around(0.75f, 1.25f, surface);
+    st[RainSettings::mbRngBPOscFrequency] *= around(0.5f, 2.f, intensity) * windCurve(3.f);
+    st[RainSettings::mbRngBPQ] *= around(4.f / 3.f, 2.f / 3.f, intensity);
+
+    // Low-Boiling: body of the rain, duller on soft surfaces
+    st[RainSettings::lbGain] *= gainCurve(intensity);
+    st[RainSettings::lbRngBPOscAmplitude] *= around(0.65f, 1.5f, intensity);
+    st[RainSettings::lbRngBPCenterFrequency] *= around(0.7f, 1.3f, surface);
+    st[RainSettings::lbRngBPOscFrequency] *= around(0.5f, 1.5f, intensity) * windCurve(2.f);
+    st[RainSettings::lbRngBPQ] *= around(1.4f, 0.7f, intensity);
+    st[RainSettings::lbLPFCutoff] *= around(0.6f, 1.4f, surface);
+    st[RainSettings::lbHPFCutoff] *= around(1.2f, 0.8f, intensity);
+
+    // Stereo Noise: wide wash, opened up and pushed forward by wind
+    st[RainSettings::stGain] *= around(1.f / 3.f, 5.f / 3.f, intensity) * fadeIn(intensity) * windCurve(1.8f);
+    st[RainSettings::stLPFCutoff] *= around(0.8f, 1.2f, intensity) * windCurve(2.f);
+    st[RainSettings::stHPFCutoff] *= around(0.8f, 1.2f, surface);
+    st[RainSettings::stPeakFreq] *= windCurve(1.6f);
+
+    // Drop Component: individual drops dominate light rain and hard surfaces
+    st[RainSettings::dropGain] *= around(0.7f, 1.3f, surface) * around(1.25f, 0.8f, intensity) * fadeIn(intensity);
+    st[RainSettings::dropRetriggerTime] *= around(2.f, 2.f / 3.f, intensity);
+    st[RainSettings::dropFreqInterval] *= around(0.5f, 2.f, surface);
+    st[RainSettings::dropTimeInterval] *= around(1.5f, 0.5f, surface);
+    st[RainSettings::dropTriggerChance] *= around(0.2f, 4.f, intensity) * fadeIn(intensity);
+
+    return st;
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    RainMacroTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+#include <vector>
+#include <JuceHeader.h>
+
+// Every value the layers read once per control tick, indexed by Field.
+struct RainSettings
+{
+    enum Field
+    {
+        //  Mid-Boiling
+        mbGain = 0,
+        mbBPCutoff,
+        mbBPQ,
+        mbRandomModulateAmplitude,
+        mbRngBPOscAmplitude,
+        mbRngBPCenterFrequency,
+        mbRngBPOscFrequency,
+        mbRngBPQ,
+
+        // Low-Boiling
+        lbGain,
+        lbRngBPOscAmplitude,
+        lbRngBPCenterFrequency,
+        lbRngBPOscFrequency,
+        lbRngBPQ,
+        lbLPFCutoff,
+        lbHPFCutoff,
+
+        // Stereo Noise
+        stGain,
+        stLPFCutoff,
+        stHPFCutoff,
+        stPeakFreq,
+
+        // Drop Component
+        dropGain,
+        dropRetriggerTime,
+        dropFreqInterval,
+        dropTimeInterval,
+        dropTriggerChance, // Probability of a new drop per tick once the last one finished
+
+        numFields
+    };
+
+    float operator[](Field field) const { return values[field]; }
+    float& operator[](Field field) { return values[field]; }
+
+    std::array<float, numFields> values {};
+};
+
+// Precomputed intensity x wind x surface -> RainSettings.
+// All curves are evaluated once in build(); lookups on the audio thread only
+// do a trilinear blend of the 8 surrounding grid points.
+class RainMacroTable
+{
+public:
+    // The curves are scaled so that intensity 0.5, no wind and surface 0.5 give back
+    // exactly the defaults passed in here.
+    void build(const RainSettings& defaults);
+
+    // All inputs in [0, 1]. Surface goes from soft (soil, grass) to hard (roof, pavement).
+    void lookup(float intensity, float wind, float surface, RainSettings& result) const;
+
+    static const int intensitySteps = 17;
+    static const int windSteps = 9;
+    static const int surfaceSteps = 5;
+
+private:
+    static RainSettings evaluate(const RainSettings& defaults, float intensity, float wind, float surface);
+    const RainSettings& at(int i, int w, int s) const
+    {
+        return table[(i * windSteps + w) * surfaceSteps + s];
+    }
+
+    std::vector<RainSettings> table;
+};